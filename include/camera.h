@@ -4,7 +4,20 @@
 #include "rtweekend.h"
 
 #include "hittable.h"
+#include "hdr_image.h"
 #include "material.h"
+#include "tonemap.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// The order pixels are visited in while rendering. Row major is the
+// plain scanline order. Morton and Hilbert split the image into square
+// tiles and walk each tile along a space filling curve, so pixels that
+// are rendered one after another are also next to each other on screen
+// and their rays tend to hit the same objects.
+enum class pixel_order { row_major, morton, hilbert };
 
 class camera {
   public:
@@ -18,23 +31,60 @@ class camera {
     point3 lookat = point3(0,0,-1); // Point camera is looking at
     vec3 vup = vec3(0,1,0); // Camera-relative "up" direction
 
-    void render(const hittable& world, std::string& out) {
+    pixel_order order = pixel_order::row_major; // Order the pixels are traversed in
+    int tile_size = 16; // Width and height of a curve tile in pixels. Rounded up to a power of 2
+    int pixel_block = 1; // Count of consecutive pixels in traversal order that have their samples interleaved
+    bool show_progress = true; // Print the remaining pixel count while rendering
+
+    // Renders the scene into a linear HDR image. Nothing is clamped or gamma
+    // corrected here; that is left to tonemap() or write_color.
+    void render(const hittable& world, hdr_image& image) {
         initialize();
 
-        out += "P3\n" + std::to_string(image_width) + ' ' + std::to_string(image_height) + "\n255\n";
+        std::vector<color> framebuffer(size_t(image_width) * image_height);
+
+        // Render a block of pixels at a time. Every pixel in the block gets
+        // its first sample, then every pixel gets its second sample, and so on.
+        // With a block of 1 this is the same as finishing each pixel in turn.
+        size_t pixel_count = traversal.size();
+        size_t block = pixel_block < 1 ? 1 : size_t(pixel_block);
+        size_t next_report = 0;
 
-        for (int j = 0; j < image_height; j++) {
-            std::cout << "\rScanlines remaining: " << (image_height - j) << ' ' << std::endl;
-            for (int i = 0; i < image_width; i++) {
-                color pixel_color(0, 0, 0);
-                for(int sample = 0; sample < samples_per_pixel; sample++) {
+        for (size_t start = 0; start < pixel_count; start += block) {
+            if (show_progress && start >= next_report) {
+                std::cout << "\rPixels remaining: " << (pixel_count - start) << ' ' << std::endl;
+                next_report += image_width;
+            }
+
+            size_t end = std::min(start + block, pixel_count);
+            for (int sample = 0; sample < samples_per_pixel; sample++) {
+                for (size_t k = start; k < end; k++) {
+                    int i = traversal[k] % image_width;
+                    int j = traversal[k] / image_width;
                     ray r = get_ray(i, j); // Pick a range in a box around the original point to sample
-                    pixel_color += ray_color(r, max_depth, world); // Add all samples into one color
+                    framebuffer[traversal[k]] += ray_color(r, max_depth, world); // Add all samples into one color
                 }
-                write_color(out, pixel_samples_scale * pixel_color); // Divide the sum of colors by the total number of samples
             }
         }
-        std::cout << "\rDone.                 \n";
+
+        // The framebuffer is always stored row major, so the image comes
+        // out in the same order no matter how it was traversed
+        image = hdr_image(image_width, image_height);
+        for (size_t idx = 0; idx < framebuffer.size(); idx++)
+            image.set(idx, pixel_samples_scale * framebuffer[idx]); // Divide the sum of colors by the total number of samples
+
+        if (show_progress)
+            std::cout << "\rDone.                 \n";
+    }
+
+    // Renders straight to an 8 bit ASCII PPM with the default tone mapping
+    void render(const hittable& world, std::string& out) {
+        hdr_image image;
+        render(world, image);
+
+        std::vector<unsigned char> bytes;
+        tonemap(image, tonemap_settings(), bytes);
+        write_ppm(out, image.width, image.height, bytes);
     }
 
   private:
@@ -45,6 +95,7 @@ class camera {
     vec3 pixel_delta_u; // Offset to pixel to the right
     vec3 pixel_delta_v; // Offset to pixel below
     vec3 u, v, w; // Camera frame basis vectors
+    std::vector<int> traversal; // Row major pixel indices in the order they are rendered
 
     void initialize() {
         // Calculate the image height, and ensure that it's at least 1.
@@ -79,6 +130,84 @@ class camera {
         // Calculate the location of the upper left pixel.
         auto viewport_upper_left = camera_center - (focal_length * w) - viewport_u/2 - viewport_v/2;
         pixel00_loc = viewport_upper_left + 0.5 * (pixel_delta_u + pixel_delta_v); // This finds the center of pixel 00
+
+        build_traversal();
+    }
+
+    void build_traversal() {
+        traversal.clear();
+        traversal.reserve(size_t(image_width) * image_height);
+
+        if (order == pixel_order::row_major) {
+            for (int idx = 0; idx < image_width * image_height; idx++)
+                traversal.push_back(idx);
+            return;
+        }
+
+        // Both curves need a power of 2 sized square to walk. A tile never has
+        // to be bigger than the image, so a huge tile_size is capped there
+        // instead of walking curve positions that are all off the image.
+        int side = 1;
+        while (side < tile_size && side < std::max(image_width, image_height))
+            side *= 2;
+
+        // Visit the tiles in row major order and walk the curve inside each one.
+        // Tiles on the right and bottom edges can hang off the image, so curve
+        // positions outside of the image are skipped.
+        for (int tile_y = 0; tile_y < image_height; tile_y += side) {
+            for (int tile_x = 0; tile_x < image_width; tile_x += side) {
+                for (size_t d = 0; d < size_t(side) * side; d++) {
+                    int x, y;
+                    if (order == pixel_order::morton)
+                        morton_d2xy(d, x, y);
+                    else
+                        hilbert_d2xy(side, d, x, y);
+
+                    int i = tile_x + x;
+                    int j = tile_y + y;
+                    if (i < image_width && j < image_height)
+                        traversal.push_back(j * image_width + i);
+                }
+            }
+        }
+    }
+
+    // Pulls every other bit out of a Morton code. The even bits are x and
+    // the odd bits are y.
+    static int compact_bits(size_t d) {
+        int result = 0;
+        for (int bit = 0; d != 0; bit++, d >>= 2)
+            result |= int(d & 1) << bit;
+        return result;
+    }
+
+    static void morton_d2xy(size_t d, int& x, int& y) {
+        x = compact_bits(d);
+        y = compact_bits(d >> 1);
+    }
+
+    // Converts a distance along a Hilbert curve filling a side x side square
+    // into the x, y position on that square. Each step of the loop picks
+    // which quadrant we are in and rotates the curve so that it stays
+    // connected between quadrants.
+    static void hilbert_d2xy(int side, size_t d, int& x, int& y) {
+        x = y = 0;
+        for (int s = 1; s < side; s *= 2) {
+            int rx = int(1 & (d / 2));
+            int ry = int(1 & (d ^ size_t(rx)));
+
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = s - 1 - x;
+                    y = s - 1 - y;
+                }
+                std::swap(x, y);
+            }
+
+            x += s * rx;
+            y += s * ry;
+            d /= 4;
+        }
     }
 
         ray get_ray(int i, int j) const {
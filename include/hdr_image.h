@@ -0,0 +1,116 @@
+#ifndef HDR_IMAGE_H
+#define HDR_IMAGE_H
+
+#include "rtweekend.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// A linear, floating point RGB image. This is what the camera renders
+// into before any gamma or clamping is applied, so the full dynamic
+// range of the render is kept around. Pixels are stored row major from
+// the top left, with the three channels next to each other.
+class hdr_image {
+  public:
+    int width = 0;
+    int height = 0;
+    std::vector<float> pixels; // r, g, b, r, g, b, ...
+
+    hdr_image() {}
+    hdr_image(int width, int height)
+    : width(width), height(height), pixels(size_t(width) * height * 3, 0.0f) {}
+
+    size_t pixel_count() const { return size_t(width) * height; }
+
+    void set(size_t idx, const color& c) {
+        pixels[3*idx + 0] = float(c.x());
+        pixels[3*idx + 1] = float(c.y());
+        pixels[3*idx + 2] = float(c.z());
+    }
+
+    color get(size_t idx) const {
+        return color(pixels[3*idx + 0], pixels[3*idx + 1], pixels[3*idx + 2]);
+    }
+
+    // Writes the image as a binary PFM (portable float map). The format is a
+    // small text header followed by raw 32 bit floats. The sign of the scale
+    // in the header says the byte order: negative for little endian.
+    // PFM stores the bottom row first, so the rows are flipped on the way out.
+    bool write_pfm(const std::string& path) const {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+
+        std::fprintf(file, "PF\n%d %d\n%s\n", width, height, host_is_little_endian() ? "-1.0" : "1.0");
+
+        size_t row_floats = size_t(width) * 3;
+        bool ok = true;
+        for (int j = height - 1; j >= 0 && ok; j--)
+            ok = std::fwrite(&pixels[j * row_floats], sizeof(float), row_floats, file) == row_floats;
+
+        return std::fclose(file) == 0 && ok;
+    }
+
+    // Reads a color PFM written by write_pfm or any other tool. Grayscale
+    // ("Pf") files are not supported.
+    bool read_pfm(const std::string& path) {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+
+        char magic[3] = {0, 0, 0};
+        int w = 0, h = 0;
+        double scale = 0;
+        // The single whitespace character after the scale ends the header
+        if (std::fscanf(file, "%2s %d %d %lf", magic, &w, &h, &scale) != 4
+            || std::strcmp(magic, "PF") != 0 || w <= 0 || h <= 0 || scale == 0
+            || std::fgetc(file) == EOF) {
+            std::fclose(file);
+            return false;
+        }
+
+        // Make sure the file really holds that many pixels before allocating
+        // them, so a corrupt header is a failed read and not a huge allocation
+        long data_start = std::ftell(file);
+        bool seek_ok = data_start >= 0 && std::fseek(file, 0, SEEK_END) == 0;
+        long data_end = seek_ok ? std::ftell(file) : -1;
+        if (data_end < data_start || std::fseek(file, data_start, SEEK_SET) != 0
+            || uint64_t(data_end - data_start) / (3 * sizeof(float)) / uint64_t(w) < uint64_t(h)) {
+            std::fclose(file);
+            return false;
+        }
+
+        *this = hdr_image(w, h);
+
+        size_t row_floats = size_t(width) * 3;
+        bool ok = true;
+        for (int j = height - 1; j >= 0 && ok; j--)
+            ok = std::fread(&pixels[j * row_floats], sizeof(float), row_floats, file) == row_floats;
+        std::fclose(file);
+
+        // Swap the bytes around if the file was written on the other endianness
+        if (ok && (scale < 0) != host_is_little_endian()) {
+            for (auto& value : pixels) {
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                bits = (bits >> 24) | ((bits >> 8) & 0xff00) | ((bits << 8) & 0xff0000) | (bits << 24);
+                std::memcpy(&value, &bits, sizeof(bits));
+            }
+        }
+
+        return ok;
+    }
+
+  private:
+    static bool host_is_little_endian() {
+        const uint32_t one = 1;
+        unsigned char first_byte;
+        std::memcpy(&first_byte, &one, 1);
+        return first_byte == 1;
+    }
+};
+
+#endif
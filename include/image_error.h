@@ -0,0 +1,109 @@
+#ifndef IMAGE_ERROR_H
+#define IMAGE_ERROR_H
+
+#include "rtweekend.h"
+#include "hdr_image.h"
+
+#include <vector>
+
+// Ways of measuring how far a render is from a reference render of the
+// same scene. All of them expect both images to be the same size.
+
+// Root mean squared error over every channel, in linear color
+inline double rmse(const hdr_image& image, const hdr_image& reference) {
+    double sum = 0;
+    for (size_t k = 0; k < image.pixels.size(); k++) {
+        double diff = double(image.pixels[k]) - reference.pixels[k];
+        sum += diff * diff;
+    }
+    return std::sqrt(sum / image.pixels.size());
+}
+
+// Mean squared error where each channel is divided by the reference value
+// squared. Without this, bright parts of the image would outweigh the
+// noise in the dark parts. The small epsilon keeps black pixels from
+// dividing by zero.
+inline double relative_mse(const hdr_image& image, const hdr_image& reference) {
+    const double epsilon = 1e-2;
+    double sum = 0;
+    for (size_t k = 0; k < image.pixels.size(); k++) {
+        double diff = double(image.pixels[k]) - reference.pixels[k];
+        double ref = reference.pixels[k];
+        sum += diff * diff / (ref * ref + epsilon);
+    }
+    return sum / image.pixels.size();
+}
+
+// Structural similarity index. 1 means the images look the same and lower
+// means they look more different. It compares the local mean, contrast and
+// structure of both images in 8x8 windows. It is computed on the gamma 2,
+// clamped luminance, since that is closer to what ends up on screen.
+inline double ssim(const hdr_image& image, const hdr_image& reference) {
+    const int window = 8;
+    const double c1 = 0.01 * 0.01; // Stabilizing constants for a dynamic range of 1
+    const double c2 = 0.03 * 0.03;
+
+    int w = image.width;
+    int h = image.height;
+    if (w < window || h < window)
+        return 1.0;
+
+    // Summed area tables of x, y, x^2, y^2 and x*y make every window sum
+    // four lookups. They are one larger in each direction so that the
+    // first row and column are zero.
+    size_t stride = size_t(w) + 1;
+    std::vector<double> sx(stride * (h + 1), 0.0), sy(sx), sxx(sx), syy(sx), sxy(sx);
+
+    static const interval intensity(0.0, 1.0);
+    auto luminance = [](const hdr_image& img, size_t idx) {
+        color c = img.get(idx);
+        double y = 0.2126 * c.x() + 0.7152 * c.y() + 0.0722 * c.z();
+        return intensity.clamp(linear_to_gamma(y));
+    };
+
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            size_t idx = size_t(j) * w + i;
+            double x = luminance(image, idx);
+            double y = luminance(reference, idx);
+
+            size_t at = (j + 1) * stride + (i + 1);
+            size_t up = j * stride + (i + 1);
+            size_t left = (j + 1) * stride + i;
+            size_t diag = j * stride + i;
+            sx[at]  = x     + sx[up]  + sx[left]  - sx[diag];
+            sy[at]  = y     + sy[up]  + sy[left]  - sy[diag];
+            sxx[at] = x * x + sxx[up] + sxx[left] - sxx[diag];
+            syy[at] = y * y + syy[up] + syy[left] - syy[diag];
+            sxy[at] = x * y + sxy[up] + sxy[left] - sxy[diag];
+        }
+    }
+
+    auto window_sum = [&](const std::vector<double>& table, int i, int j) {
+        size_t top = size_t(j) * stride;
+        size_t bottom = size_t(j + window) * stride;
+        return table[bottom + i + window] - table[top + i + window] - table[bottom + i] + table[top + i];
+    };
+
+    const double n = window * window;
+    double total = 0;
+    size_t count = 0;
+
+    for (int j = 0; j + window <= h; j++) {
+        for (int i = 0; i + window <= w; i++) {
+            double mean_x = window_sum(sx, i, j) / n;
+            double mean_y = window_sum(sy, i, j) / n;
+            double var_x = window_sum(sxx, i, j) / n - mean_x * mean_x;
+            double var_y = window_sum(syy, i, j) / n - mean_y * mean_y;
+            double cov = window_sum(sxy, i, j) / n - mean_x * mean_y;
+
+            total += ((2 * mean_x * mean_y + c1) * (2 * cov + c2))
+                   / ((mean_x * mean_x + mean_y * mean_y + c1) * (var_x + var_y + c2));
+            count++;
+        }
+    }
+
+    return total / count;
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include "rtweekend.h"
+#include "triangle_mesh.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads the geometry out of a Wavefront OBJ file. Only vertex positions
+// ("v") and faces ("f") are used. Texture coordinates, normals, groups
+// and materials are skipped. Faces with more than three corners are
+// split into a fan of triangles.
+//
+// The file is streamed in fixed size chunks rather than read in all at
+// once, so the text of a huge file never sits in memory. Each batch of
+// chunks is parsed on several threads and then appended in file order.
+class obj_loader {
+  public:
+    size_t chunk_bytes = size_t(4) << 20; // Size of the piece of the file each thread parses
+    unsigned int thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    // Returns false and prints why if the file can't be read or has a bad vertex or face
+    bool load(const std::string& path, std::vector<point3>& vertices, std::vector<int>& indices) const {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Could not open " << path << '\n';
+            return false;
+        }
+
+        vertices.clear();
+        indices.clear();
+
+        std::vector<chunk> batch(std::max(1u, thread_count));
+        std::string leftover; // Partial line carried over from the end of the last chunk
+        bool ok = true;
+
+        while (ok && (file || !leftover.empty())) {
+            // Fill up one chunk per thread. Each chunk is cut at its last newline
+            // and the rest of the line moves on to the front of the next chunk.
+            size_t filled = 0;
+            while (filled < batch.size() && (file || !leftover.empty())) {
+                std::string& text = batch[filled].text;
+                text.swap(leftover);
+                leftover.clear();
+
+                size_t old_size = text.size();
+                text.resize(old_size + chunk_bytes);
+                file.read(&text[old_size], std::streamsize(chunk_bytes));
+                text.resize(old_size + size_t(file.gcount()));
+
+                if (file) {
+                    size_t last_newline = text.rfind('\n');
+                    if (last_newline == std::string::npos) {
+                        // No full line yet, so keep reading into this chunk
+                        leftover.swap(text);
+                        continue;
+                    }
+                    leftover.assign(text, last_newline + 1, std::string::npos);
+                    text.resize(last_newline + 1);
+                }
+                filled++;
+            }
+
+            std::vector<std::thread> workers;
+            for (size_t k = 1; k < filled; k++)
+                workers.emplace_back(parse_chunk, std::ref(batch[k]));
+            if (filled > 0)
+                parse_chunk(batch[0]);
+            for (auto& worker : workers)
+                worker.join();
+
+            for (size_t k = 0; k < filled && ok; k++)
+                ok = append_chunk(batch[k], vertices, indices);
+        }
+
+        if (!ok) {
+            std::cerr << "Bad vertex or face in " << path << '\n';
+            return false;
+        }
+
+        // Faces are allowed to point at vertices that come later in the file,
+        // so the indices can only be checked once everything is read
+        for (int index : indices) {
+            if (index < 0 || size_t(index) >= vertices.size()) {
+                std::cerr << "Face refers to a missing vertex in " << path << '\n';
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Convenience wrapper that builds the mesh. Returns nullptr if loading failed.
+    shared_ptr<triangle_mesh> load_mesh(const std::string& path, shared_ptr<material> mat) const {
+        std::vector<point3> vertices;
+        std::vector<int> indices;
+        if (!load(path, vertices, indices))
+            return nullptr;
+        return make_shared<triangle_mesh>(std::move(vertices), std::move(indices), mat);
+    }
+
+  private:
+    // A face corner as it was written in the file. Positive OBJ indices
+    // count from the first vertex of the file, negative ones count back
+    // from the newest vertex. A chunk doesn't know how many vertices came
+    // before it, so relative corners are stored against the chunk's own
+    // vertices and fixed up when the chunk is appended.
+    struct corner {
+        int64_t index;
+        bool relative;
+    };
+
+    struct chunk {
+        std::string text;
+        std::vector<point3> vertices;
+        std::vector<corner> corners; // Three per triangle
+        bool ok = true;
+    };
+
+    static bool is_space(char ch) { return ch == ' ' || ch == '\t' || ch == '\r'; }
+
+    static void parse_chunk(chunk& c) {
+        c.vertices.clear();
+        c.corners.clear();
+        c.ok = true;
+
+        const char* p = c.text.c_str();
+        const char* end = p + c.text.size();
+        std::vector<corner> face;
+
+        while (p < end && c.ok) {
+            const char* line_end = std::find(p, end, '\n');
+
+            while (p < line_end && is_space(*p))
+                p++;
+
+            if (line_end - p > 1 && p[0] == 'v' && is_space(p[1])) {
+                // A fourth weight value is allowed but not used
+                double xyz[3] = {0, 0, 0};
+                p += 2;
+                for (int axis = 0; axis < 3 && c.ok; axis++)
+                    c.ok = parse_number(p, line_end, xyz[axis]);
+                c.vertices.push_back(point3(xyz[0], xyz[1], xyz[2]));
+            } else if (line_end - p > 1 && p[0] == 'f' && is_space(p[1])) {
+                face.clear();
+                p += 2;
+                while (p < line_end) {
+                    while (p < line_end && is_space(*p))
+                        p++;
+                    if (p >= line_end || *p == '#')
+                        break; // The rest of the line is a comment
+
+                    corner next_corner;
+                    if (!parse_corner(p, line_end, int64_t(c.vertices.size()), next_corner)) {
+                        c.ok = false;
+                        break;
+                    }
+                    face.push_back(next_corner);
+                }
+
+                if (face.size() < 3)
+                    c.ok = false;
+
+                // Fan out from the first corner
+                for (size_t k = 2; k < face.size() && c.ok; k++) {
+                    c.corners.push_back(face[0]);
+                    c.corners.push_back(face[k-1]);
+                    c.corners.push_back(face[k]);
+                }
+            }
+
+            p = line_end + 1;
+        }
+
+        // The text isn't needed anymore, but keep its memory for the next batch
+        c.text.clear();
+    }
+
+    // Reads one coordinate of a vertex. strtod would skip past the newline
+    // and take the next line's number if this line ran short, so the number
+    // has to start and end before the end of the line.
+    static bool parse_number(const char*& p, const char* line_end, double& out) {
+        while (p < line_end && is_space(*p))
+            p++;
+        if (p >= line_end || *p == '#')
+            return false;
+
+        // The text always ends in a null, so strtod can't run off the end
+        char* next;
+        out = std::strtod(p, &next);
+        if (next == p || next > line_end)
+            return false;
+
+        p = next;
+        return true;
+    }
+
+    // Reads the vertex index of one "v", "v/vt", "v//vn" or "v/vt/vn" corner
+    static bool parse_corner(const char*& p, const char* line_end, int64_t local_vertex_count, corner& out) {
+        bool negative = false;
+        if (*p == '-') {
+            negative = true;
+            p++;
+        }
+
+        int64_t value = 0;
+        const char* digits_start = p;
+        while (p < line_end && *p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            if (value > INT32_MAX)
+                return false;
+            p++;
+        }
+        if (p == digits_start || value == 0)
+            return false;
+
+        // Skip over the texture and normal indices
+        while (p < line_end && !is_space(*p) && *p != '#')
+            p++;
+
+        if (negative) {
+            out.index = local_vertex_count - value;
+            out.relative = true;
+        } else {
+            out.index = value - 1;
+            out.relative = false;
+        }
+        return true;
+    }
+
+    static bool append_chunk(const chunk& c, std::vector<point3>& vertices, std::vector<int>& indices) {
+        if (!c.ok)
+            return false;
+
+        int64_t base = int64_t(vertices.size());
+        vertices.insert(vertices.end(), c.vertices.begin(), c.vertices.end());
+
+        for (const auto& corner : c.corners) {
+            int64_t index = corner.relative ? base + corner.index : corner.index;
+            if (index < 0 || index > INT32_MAX)
+                return false;
+            indices.push_back(int(index));
+        }
+        return true;
+    }
+};
+
+#endif
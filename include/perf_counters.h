@@ -0,0 +1,175 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Wraps a section of code with hardware performance counters so we can
+// see how cache friendly the render loop is. On Linux this uses
+// perf_event_open. If the counters can't be opened (other platforms,
+// containers, or a strict perf_event_paranoid setting), only the wall
+// clock time is reported.
+//
+// All the counters are opened as one group, so the kernel always
+// schedules them together and the miss ratios compare counts taken over
+// the same period. If the group had to share the hardware with other
+// events, the counts are scaled up to the full run and the report says so.
+class perf_counters {
+  public:
+    perf_counters() {
+        for (int k = 0; k < num_counters; k++) {
+            fds[k] = -1;
+            values[k] = 0;
+        }
+
+#ifdef __linux__
+        const uint64_t configs[num_counters] = {
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_REFERENCES,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+            PERF_COUNT_HW_BRANCH_MISSES,
+        };
+
+        // The first counter that opens leads the group and the rest join it.
+        // A counter the CPU doesn't support is just left out.
+        for (int k = 0; k < num_counters; k++) {
+            fds[k] = open_counter(configs[k], leader);
+            if (leader < 0)
+                leader = fds[k];
+        }
+#endif
+    }
+
+    ~perf_counters() {
+#ifdef __linux__
+        for (int k = 0; k < num_counters; k++) {
+            if (fds[k] >= 0)
+                close(fds[k]);
+        }
+#endif
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    void start() {
+#ifdef __linux__
+        if (leader >= 0) {
+            ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+        start_time = std::chrono::steady_clock::now();
+    }
+
+    void stop() {
+        auto end_time = std::chrono::steady_clock::now();
+        seconds = std::chrono::duration<double>(end_time - start_time).count();
+
+#ifdef __linux__
+        if (leader < 0)
+            return;
+
+        ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // With PERF_FORMAT_GROUP one read returns the whole group:
+        // the number of counters, the enabled and running times, then
+        // one value per counter in the order they joined the group.
+        uint64_t data[3 + num_counters];
+        ssize_t got = read(leader, data, sizeof(data));
+        if (got < ssize_t(3 * sizeof(uint64_t)))
+            return;
+
+        uint64_t nr = data[0];
+        time_enabled = data[1];
+        time_running = data[2];
+        if (nr > num_counters || got < ssize_t((3 + nr) * sizeof(uint64_t)))
+            return;
+
+        // Scale up for the part of the run the group wasn't on the hardware
+        double scale = time_running > 0 ? double(time_enabled) / time_running : 0.0;
+
+        size_t next = 0;
+        for (int k = 0; k < num_counters; k++) {
+            if (fds[k] >= 0 && next < nr)
+                values[k] = uint64_t(data[3 + next++] * scale + 0.5);
+        }
+#endif
+    }
+
+    double elapsed_seconds() const { return seconds; }
+
+    void report(std::ostream& os) const {
+        static const char* names[num_counters] = {
+            "instructions", "cache-references", "cache-misses", "branches", "branch-misses"
+        };
+
+        os << "time:              " << seconds << " s\n";
+
+        bool any_open = false;
+        for (int k = 0; k < num_counters; k++) {
+            if (fds[k] < 0)
+                continue;
+
+            any_open = true;
+            os << names[k] << ':' << std::string(19 - std::strlen(names[k]) - 1, ' ') << values[k];
+
+            // Give the miss counters as a ratio of the thing they missed on
+            if (k == cache_misses && fds[cache_references] >= 0 && values[cache_references] > 0)
+                os << " (" << 100.0 * values[k] / values[cache_references] << "% of references)";
+            if (k == branch_misses && fds[branches] >= 0 && values[branches] > 0)
+                os << " (" << 100.0 * values[k] / values[branches] << "% of branches)";
+
+            os << '\n';
+        }
+
+        if (!any_open) {
+            os << "hardware counters unavailable\n";
+        } else if (time_running < time_enabled) {
+            os << "counters were multiplexed: measured for "
+               << (time_enabled > 0 ? 100.0 * time_running / time_enabled : 0.0)
+               << "% of the run and scaled up\n";
+        }
+    }
+
+  private:
+    enum { instructions, cache_references, cache_misses, branches, branch_misses, num_counters };
+
+    int fds[num_counters];
+    int leader = -1; // File descriptor of the group leader
+    uint64_t values[num_counters];
+    uint64_t time_enabled = 0; // Nanoseconds the group was enabled
+    uint64_t time_running = 0; // Nanoseconds the group was actually counting
+    double seconds = 0;
+    std::chrono::steady_clock::time_point start_time;
+
+#ifdef __linux__
+    static int open_counter(uint64_t config, int group_fd) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = group_fd < 0; // Only the leader starts disabled; the group follows it
+        attr.exclude_kernel = 1; // Only count our own code, which also works with paranoid level 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // pid 0, cpu -1 counts this process on whatever CPU it runs on
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+    }
+#endif
+};
+
+#endif
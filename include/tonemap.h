@@ -0,0 +1,93 @@
+#ifndef TONEMAP_H
+#define TONEMAP_H
+
+#include "rtweekend.h"
+#include "hdr_image.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Settings for turning a linear HDR render into displayable 8 bit color.
+// This runs after the render is done, so the same render can be
+// regraded as many times as we want without tracing any more rays.
+struct tonemap_settings {
+    double exposure = 0.0; // In stops. Every +1 doubles the brightness
+    double gamma = 2.0; // Matches the gamma 2 transform in write_color
+    bool filmic = false; // Roll off highlights with a filmic curve instead of hard clipping
+};
+
+// Narkowicz's fit of the ACES filmic curve. Dark values stay close to
+// linear, while bright values are squeezed towards 1 instead of clipping.
+inline float filmic_curve(float x) {
+    return (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+}
+
+// Linear to gamma, then the same [0, 0.999] clamp and quantization as
+// write_color. Gamma 2 goes through linear_to_gamma so the rounding
+// matches write_color exactly.
+inline int gamma_byte(double linear, double gamma) {
+    static const interval intensity(0.0, 0.999);
+    double gamma_corrected = gamma == 2.0 ? linear_to_gamma(linear) : std::pow(linear, 1.0 / gamma);
+    return int(255.999 * intensity.clamp(gamma_corrected));
+}
+
+// Tone maps every channel of the image into bytes. This is split into
+// two passes so the first one is a plain loop over floats that the
+// compiler can vectorize. The gamma curve is the expensive part, so
+// instead of evaluating it per channel we find the 255 linear values
+// where the output byte steps up, and the second pass searches those.
+// The thresholds are found exactly, so the bytes are the same as
+// calling gamma_byte on every channel.
+inline void tonemap(const hdr_image& image, const tonemap_settings& settings, std::vector<unsigned char>& bytes) {
+    const float scale = float(std::pow(2.0, settings.exposure));
+
+    size_t count = image.pixels.size();
+    std::vector<float> mapped(count);
+    const float* src = image.pixels.data();
+    float* dst = mapped.data();
+
+    // Pass 1: exposure, optional filmic curve and clamp to [0, 1]
+    if (settings.filmic) {
+        for (size_t k = 0; k < count; k++) {
+            float x = src[k] * scale;
+            x = x > 0.0f ? x : 0.0f; // Also turns NaNs into black
+            dst[k] = std::min(filmic_curve(x), 1.0f);
+        }
+    } else {
+        for (size_t k = 0; k < count; k++) {
+            float x = src[k] * scale;
+            x = x > 0.0f ? x : 0.0f; // Also turns NaNs into black
+            dst[k] = std::min(x, 1.0f);
+        }
+    }
+
+    // thresholds[b-1] is the smallest float that maps to byte b or higher.
+    // Byte b starts at (b/255.999)^gamma. That guess can be off by a little
+    // from rounding, so step it one float at a time until it sits exactly
+    // on the boundary.
+    float thresholds[255];
+    for (int b = 1; b <= 255; b++) {
+        float t = float(std::pow(b / 255.999, settings.gamma));
+        while (t > 0.0f && gamma_byte(std::nextafter(t, 0.0f), settings.gamma) >= b)
+            t = std::nextafter(t, 0.0f);
+        while (t < 1.0f && gamma_byte(t, settings.gamma) < b)
+            t = std::nextafter(t, 1.0f);
+        thresholds[b-1] = t;
+    }
+
+    // Pass 2: the byte is the number of thresholds at or below the value
+    bytes.resize(count);
+    for (size_t k = 0; k < count; k++)
+        bytes[k] = (unsigned char)(std::upper_bound(thresholds, thresholds + 255, dst[k]) - thresholds);
+}
+
+// Writes tone mapped bytes out as the same ASCII PPM that the renderer has always produced
+inline void write_ppm(std::string& out, int width, int height, const std::vector<unsigned char>& bytes) {
+    out += "P3\n" + std::to_string(width) + ' ' + std::to_string(height) + "\n255\n";
+
+    for (size_t k = 0; k + 2 < bytes.size(); k += 3)
+        out += std::to_string(bytes[k]) + ' ' + std::to_string(bytes[k+1]) + ' ' + std::to_string(bytes[k+2]) + '\n';
+}
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef TRIANGLE_MESH_H
+#define TRIANGLE_MESH_H
+
+#include "rtweekend.h"
+#include "hittable.h"
+#include "hittable_list.h"
+
+#include <utility>
+#include <vector>
+
+// A mesh of triangles that share one vertex buffer. Every three entries
+// of the index buffer are the vertices of one triangle, so a vertex that
+// is used by several triangles is only stored once.
+class triangle_mesh : public hittable {
+  public:
+    triangle_mesh(std::vector<point3> vertices, std::vector<int> indices, shared_ptr<material> mat)
+    : vertices(std::move(vertices)), indices(std::move(indices)), mat(mat)
+    {
+        // Box around every vertex so rays that miss the whole mesh are thrown out early
+        for (const auto& vertex : this->vertices) {
+            for (int axis = 0; axis < 3; axis++) {
+                box_min[axis] = std::fmin(box_min[axis], vertex[axis]);
+                box_max[axis] = std::fmax(box_max[axis], vertex[axis]);
+            }
+        }
+    }
+
+    size_t triangle_count() const { return indices.size() / 3; }
+
+    bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+        if (!hit_box(r, ray_t))
+            return false;
+
+        // The ray only has to be set up once for the whole mesh
+        ray_setup setup(r);
+        bool hit_anything = false;
+
+        // Same as hittable_list: shrink the interval as closer hits are found
+        for (size_t tri = 0; tri < triangle_count(); tri++) {
+            if (hit_triangle(tri, setup, r, ray_t, rec)) {
+                hit_anything = true;
+                ray_t.max = rec.t;
+            }
+        }
+
+        return hit_anything;
+    }
+
+    // Tests a single triangle. This is what mesh_triangle calls so that an
+    // acceleration structure can hold triangles one at a time.
+    bool hit_triangle(size_t tri, const ray& r, interval ray_t, hit_record& rec) const {
+        return hit_triangle(tri, ray_setup(r), r, ray_t, rec);
+    }
+
+  private:
+    std::vector<point3> vertices;
+    std::vector<int> indices;
+    shared_ptr<material> mat;
+    point3 box_min = point3(+infinity, +infinity, +infinity);
+    point3 box_max = point3(-infinity, -infinity, -infinity);
+
+    // The watertight ray/triangle test from Woop, Benthin and Wald (2013).
+    // The ray is turned into a shear transform that makes it point straight
+    // down the z axis. After that every triangle can be tested in 2D, and
+    // an edge shared by two triangles gives exactly the same answer for
+    // both of them, so rays can't slip through the cracks between triangles.
+    struct ray_setup {
+        int kx, ky, kz; // Axes of the ray direction, with kz being the largest one
+        double sx, sy, sz; // Shear constants
+
+        ray_setup(const ray& r) {
+            const vec3& d = r.direction();
+
+            kz = 0;
+            if (std::fabs(d[1]) > std::fabs(d[kz])) kz = 1;
+            if (std::fabs(d[2]) > std::fabs(d[kz])) kz = 2;
+            kx = (kz + 1) % 3;
+            ky = (kx + 1) % 3;
+
+            // Swap so the winding order of the triangles is kept
+            if (d[kz] < 0)
+                std::swap(kx, ky);
+
+            sx = d[kx] / d[kz];
+            sy = d[ky] / d[kz];
+            sz = 1.0 / d[kz];
+        }
+    };
+
+    bool hit_box(const ray& r, interval ray_t) const {
+        // Slab test: the ray has to be inside all three slabs at the same time
+        for (int axis = 0; axis < 3; axis++) {
+            double inv_d = 1.0 / r.direction()[axis];
+            double t0 = (box_min[axis] - r.origin()[axis]) * inv_d;
+            double t1 = (box_max[axis] - r.origin()[axis]) * inv_d;
+            if (t0 > t1)
+                std::swap(t0, t1);
+
+            if (t0 > ray_t.min) ray_t.min = t0;
+            if (t1 < ray_t.max) ray_t.max = t1;
+            if (ray_t.max < ray_t.min)
+                return false;
+        }
+        return true;
+    }
+
+    bool hit_triangle(size_t tri, const ray_setup& s, const ray& r, interval ray_t, hit_record& rec) const {
+        const point3& p0 = vertices[indices[3*tri + 0]];
+        const point3& p1 = vertices[indices[3*tri + 1]];
+        const point3& p2 = vertices[indices[3*tri + 2]];
+
+        // Move the vertices so the ray starts at the origin
+        vec3 a = p0 - r.origin();
+        vec3 b = p1 - r.origin();
+        vec3 c = p2 - r.origin();
+
+        // Shear the vertices so the ray points down z
+        double ax = a[s.kx] - s.sx * a[s.kz];
+        double ay = a[s.ky] - s.sy * a[s.kz];
+        double bx = b[s.kx] - s.sx * b[s.kz];
+        double by = b[s.ky] - s.sy * b[s.kz];
+        double cx = c[s.kx] - s.sx * c[s.kz];
+        double cy = c[s.ky] - s.sy * c[s.kz];
+
+        // Scaled barycentric coordinates. The ray goes through the origin of
+        // this 2D space, so it hits when the origin is on the same side of
+        // all three edges.
+        double eu = cx * by - cy * bx;
+        double ev = ax * cy - ay * cx;
+        double ew = bx * ay - by * ax;
+
+        if ((eu < 0 || ev < 0 || ew < 0) && (eu > 0 || ev > 0 || ew > 0))
+            return false;
+
+        double det = eu + ev + ew;
+        if (det == 0)
+            return false; // The ray runs along the plane of the triangle
+
+        // Scaled distance to the hit point. It's only divided by det once we know
+        // the hit is inside the interval, which saves a division for misses.
+        double az = s.sz * a[s.kz];
+        double bz = s.sz * b[s.kz];
+        double cz = s.sz * c[s.kz];
+        double t_scaled = eu * az + ev * bz + ew * cz;
+
+        // Flip both signs for back facing triangles so det is positive. Then the
+        // interval can be scaled by det instead of dividing t_scaled by it.
+        if (det < 0) {
+            det = -det;
+            t_scaled = -t_scaled;
+        }
+        if (t_scaled <= ray_t.min * det || t_scaled >= ray_t.max * det)
+            return false;
+
+        double t = t_scaled / det;
+        rec.t = t;
+        rec.p = r.at(t);
+
+        vec3 outward_normal = unit_vector(cross(p1 - p0, p2 - p0));
+        rec.set_face_normal(r, outward_normal);
+        rec.mat = mat;
+
+        return true;
+    }
+};
+
+// One triangle out of a triangle_mesh. The mesh's buffers aren't copied,
+// so a mesh can be split into many of these and handed to a hittable_list
+// or an acceleration structure that wants to sort triangles on their own.
+class mesh_triangle : public hittable {
+  public:
+    mesh_triangle(shared_ptr<const triangle_mesh> mesh, size_t index) : mesh(mesh), index(index) {}
+
+    bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+        return mesh->hit_triangle(index, r, ray_t, rec);
+    }
+
+  private:
+    shared_ptr<const triangle_mesh> mesh;
+    size_t index;
+};
+
+// Adds every triangle of the mesh to the list as its own hittable
+inline void add_triangles(hittable_list& list, const shared_ptr<const triangle_mesh>& mesh) {
+    for (size_t tri = 0; tri < mesh->triangle_count(); tri++)
+        list.add(make_shared<mesh_triangle>(mesh, tri));
+}
+
+#endif
@@ -0,0 +1,203 @@
+#include "../include/rtweekend.h"
+
+#include "../include/hittable_list.h"
+#include "../include/camera.h"
+#include "../include/scenes.h"
+#include "../include/hdr_image.h"
+#include "../include/image_error.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Measures how quickly each render mode converges to a ground truth
+// image, so a performance change can be judged by how long it takes to
+// reach a given quality instead of by raw speed alone. Usage:
+//   convergence [--width w] [--reference-spp n] [--max-spp n] [--seeds n] [--rebuild]
+//
+// The ground truth is rendered once at a high sample count and cached in
+// reference_<width>_<spp>.pfm. For every mode the scene is then rendered
+// at 1, 2, 4, ... samples per pixel, once per seed. The mean time, RMSE,
+// relative MSE and SSIM over the seeds go into convergence_<mode>.csv.
+// convergence.gp plots error against time and error against samples per
+// pixel for all modes.
+//
+// The modes only change the order pixels are traversed in, not what is
+// sampled, so their error against spp should match up to noise. It is
+// the error against time that tells them apart.
+
+struct render_mode {
+    const char* name;
+    pixel_order order;
+    int pixel_block;
+};
+
+static const render_mode modes[] = {
+    { "row_major", pixel_order::row_major, 1 },
+    { "morton",    pixel_order::morton,    16 },
+    { "hilbert",   pixel_order::hilbert,   16 },
+};
+
+static double render_timed(camera& cam, const hittable& world, hdr_image& image) {
+    auto start = std::chrono::steady_clock::now();
+    cam.render(world, image);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static void write_plot_script(const std::string& path) {
+    std::ofstream gp(path, std::ios::out);
+
+    gp << "# Run with: gnuplot " << path << "\n"
+       << "set datafile separator ','\n"
+       << "set key autotitle columnhead\n"
+       << "set logscale xy\n"
+       << "set grid\n"
+       << "set terminal pngcairo size 1200,800\n";
+
+    const char* charts[][3] = {
+        // x column, x label, file suffix
+        { "2", "seconds", "time" },
+        { "1", "samples per pixel", "spp" },
+    };
+
+    for (const auto& chart : charts) {
+        gp << "\nset output 'convergence_" << chart[2] << ".png'\n"
+           << "set multiplot layout 1,2\n"
+           << "set xlabel '" << chart[1] << "'\n";
+
+        // Left: relative MSE, which should fall as 1/x. Right: SSIM, which is plotted as 1 - SSIM so it also falls
+        gp << "set ylabel 'relative MSE'\nplot ";
+        for (size_t k = 0; k < sizeof(modes) / sizeof(modes[0]); k++)
+            gp << (k ? ", " : "") << "'convergence_" << modes[k].name << ".csv' using "
+               << chart[0] << ":4 with linespoints title '" << modes[k].name << "'";
+
+        gp << "\nset ylabel '1 - SSIM'\nplot ";
+        for (size_t k = 0; k < sizeof(modes) / sizeof(modes[0]); k++)
+            gp << (k ? ", " : "") << "'convergence_" << modes[k].name << ".csv' using "
+               << chart[0] << ":(1-$5) with linespoints title '" << modes[k].name << "'";
+
+        gp << "\nunset multiplot\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    int width = 200;
+    int reference_spp = 1024;
+    int max_spp = 64;
+    int seeds = 4;
+    bool rebuild = false;
+
+    for (int k = 1; k < argc; k++) {
+        if (std::strcmp(argv[k], "--width") == 0 && k + 1 < argc) {
+            width = std::atoi(argv[++k]);
+        } else if (std::strcmp(argv[k], "--reference-spp") == 0 && k + 1 < argc) {
+            reference_spp = std::atoi(argv[++k]);
+        } else if (std::strcmp(argv[k], "--max-spp") == 0 && k + 1 < argc) {
+            max_spp = std::atoi(argv[++k]);
+        } else if (std::strcmp(argv[k], "--seeds") == 0 && k + 1 < argc) {
+            seeds = std::atoi(argv[++k]);
+        } else if (std::strcmp(argv[k], "--rebuild") == 0) {
+            rebuild = true;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--width w] [--reference-spp n] [--max-spp n] [--seeds n] [--rebuild]\n";
+            return 1;
+        }
+    }
+
+    if (width < 1 || reference_spp < 1 || max_spp < 1 || seeds < 1) {
+        std::cerr << "Width, sample and seed counts must be positive\n";
+        return 1;
+    }
+
+    hittable_list world;
+    camera cam;
+    three_spheres(world, cam);
+    cam.image_width = width;
+    cam.show_progress = false;
+
+    // Reuse the ground truth from an earlier run. It is the slow part, so
+    // it's worth keeping around. The file name records the width and sample
+    // count, so asking for a different reference renders a new one.
+    const std::string reference_path =
+        "reference_" + std::to_string(width) + "_" + std::to_string(reference_spp) + ".pfm";
+    hdr_image reference;
+    bool have_reference = !rebuild && reference.read_pfm(reference_path);
+
+    auto render_reference = [&]() {
+        std::cout << "Rendering reference at " << reference_spp << " spp..." << std::endl;
+        camera reference_cam = cam;
+        reference_cam.samples_per_pixel = reference_spp;
+        std::srand(1);
+        double seconds = render_timed(reference_cam, world, reference);
+        std::cout << "Reference took " << seconds << " s\n";
+
+        if (!reference.write_pfm(reference_path))
+            std::cerr << "Could not write " << reference_path << '\n';
+        have_reference = true;
+    };
+
+    if (!have_reference)
+        render_reference();
+
+    for (const auto& mode : modes) {
+        cam.order = mode.order;
+        cam.pixel_block = mode.pixel_block;
+
+        std::string csv_path = std::string("convergence_") + mode.name + ".csv";
+        std::ofstream csv(csv_path, std::ios::out);
+        csv << "spp,seconds,rmse,relmse,ssim,relmse_stddev\n";
+
+        std::cout << "\n" << mode.name << " (mean of " << seeds << " seeds)\n"
+                  << "  spp     seconds        rmse      relmse        ssim   relmse sd\n";
+
+        for (int spp = 1; spp <= max_spp; spp *= 2) {
+            cam.samples_per_pixel = spp;
+
+            double seconds = 0, e_rmse = 0, e_relmse = 0, e_ssim = 0, relmse_squares = 0;
+            for (int seed = 0; seed < seeds; seed++) {
+                // Seed 1 is the reference's, so start past it to keep the noise independent
+                std::srand(unsigned(2 + spp * seeds + seed));
+                hdr_image image;
+                seconds += render_timed(cam, world, image);
+
+                // The cached reference has to match what the camera actually
+                // renders. If the scene's aspect ratio changed since it was
+                // cached, the sizes won't line up and it has to be redone.
+                if (image.width != reference.width || image.height != reference.height)
+                    render_reference();
+
+                double relmse = relative_mse(image, reference);
+                e_rmse += rmse(image, reference);
+                e_relmse += relmse;
+                e_ssim += ssim(image, reference);
+                relmse_squares += relmse * relmse;
+            }
+
+            seconds /= seeds;
+            e_rmse /= seeds;
+            e_relmse /= seeds;
+            e_ssim /= seeds;
+            double relmse_stddev = std::sqrt(std::fmax(0.0, relmse_squares / seeds - e_relmse * e_relmse));
+
+            csv << spp << ',' << seconds << ',' << e_rmse << ',' << e_relmse << ',' << e_ssim
+                << ',' << relmse_stddev << '\n';
+
+            char line[128];
+            std::snprintf(line, sizeof(line), "%5d %11.4f %11.6f %11.6f %11.6f %11.6f\n",
+                          spp, seconds, e_rmse, e_relmse, e_ssim, relmse_stddev);
+            std::cout << line;
+        }
+    }
+
+    write_plot_script("convergence.gp");
+    std::cout << "\nWrote convergence_<mode>.csv. Plot them with: gnuplot convergence.gp\n";
+
+    return 0;
+}
@@ -3,39 +3,97 @@
 #include "../include/hittable.h"
 #include "../include/hittable_list.h"
 #include "../include/sphere.h"
+#include "../include/triangle_mesh.h"
+#include "../include/obj_loader.h"
+#include "../include/scenes.h"
 #include "../include/camera.h"
+#include "../include/perf_counters.h"
+#include "../include/hdr_image.h"
+#include "../include/tonemap.h"
 
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    // Usage: raytracing [--order row_major|morton|hilbert] [--tile n] [--block n] [model.obj]
+    // Rendering once with --order row_major --block 1 and once with the
+    // defaults gives the two counter reports to compare.
+    pixel_order order = pixel_order::hilbert;
+    int tile_size = 16;
+    int pixel_block = 16;
+    const char* obj_path = nullptr;
+
+    for (int k = 1; k < argc; k++) {
+        if (std::strcmp(argv[k], "--order") == 0 && k + 1 < argc) {
+            k++;
+            if (std::strcmp(argv[k], "row_major") == 0)
+                order = pixel_order::row_major;
+            else if (std::strcmp(argv[k], "morton") == 0)
+                order = pixel_order::morton;
+            else if (std::strcmp(argv[k], "hilbert") == 0)
+                order = pixel_order::hilbert;
+            else {
+                std::cerr << "Unknown pixel order " << argv[k] << '\n';
+                return 1;
+            }
+        } else if (std::strcmp(argv[k], "--tile") == 0 && k + 1 < argc) {
+            tile_size = std::atoi(argv[++k]);
+        } else if (std::strcmp(argv[k], "--block") == 0 && k + 1 < argc) {
+            pixel_block = std::atoi(argv[++k]);
+        } else if (argv[k][0] != '-' && !obj_path) {
+            obj_path = argv[k];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--order row_major|morton|hilbert] [--tile n] [--block n] [model.obj]\n";
+            return 1;
+        }
+    }
+
+    if (tile_size < 1 || pixel_block < 1) {
+        std::cerr << "Tile and block sizes must be positive\n";
+        return 1;
+    }
 
-int main() {
     std::string out;
     std::ofstream outfile("out.ppm", std::ios::out);
 
     hittable_list world;
 
-    auto material_ground = make_shared<lambertian>(color(0.8, 0.8, 0.0));
-    auto material_center = make_shared<lambertian>(color(0.1, 0.2, 0.5));
-    auto material_left = make_shared<dielectric>(1.50);
-    auto material_bubble = make_shared<dielectric>(1.00 / 1.50);
-    auto material_right  = make_shared<metal>(color(0.8, 0.6, 0.2), 1.0);
+    camera cam;
+    three_spheres(world, cam);
 
-    world.add(make_shared<sphere>(point3( 0.0, -100.5, -1.0), 100.0, material_ground));
-    world.add(make_shared<sphere>(point3( 0.0,    0.0, -1.2),   0.5, material_center));
-    world.add(make_shared<sphere>(point3(-1.0,    0.0, -1.0),   0.5, material_left));
-    world.add(make_shared<sphere>(point3(-1.0,    0.0, -1.0),   0.4, material_bubble));
-    world.add(make_shared<sphere>(point3( 1.0,    0.0, -1.0),   0.5, material_right));
+    // Optionally add a mesh from an OBJ file given on the command line
+    if (obj_path) {
+        obj_loader loader;
+        auto mesh = loader.load_mesh(obj_path, make_shared<lambertian>(color(0.7, 0.7, 0.7)));
+        if (!mesh)
+            return 1;
+        std::cout << "Loaded " << mesh->triangle_count() << " triangles from " << obj_path << '\n';
+        world.add(mesh);
+    }
 
+    cam.order       = order;
+    cam.tile_size   = tile_size;
+    cam.pixel_block = pixel_block;
 
-    camera cam;
-    cam.samples_per_pixel = 100;
-    cam.max_depth = 50;
-    cam.vfov     = 40;
-    cam.lookfrom = point3(0,0,1);
-    cam.lookat   = point3(0,0,-1);
-    cam.vup      = vec3(0,1,0);
-
-    cam.render(world, out);
+    hdr_image image;
+
+    perf_counters counters;
+    counters.start();
+    cam.render(world, image);
+    counters.stop();
+    counters.report(std::cout);
+
+    // Keep the linear render around so it can be regraded with the tonemap tool
+    if (!image.write_pfm("out.pfm"))
+        std::cerr << "Could not write out.pfm\n";
+
+    std::vector<unsigned char> bytes;
+    tonemap(image, tonemap_settings(), bytes);
+    write_ppm(out, image.width, image.height, bytes);
 
     if(outfile.is_open()) {
         outfile << out;
@@ -0,0 +1,69 @@
+#include "../include/rtweekend.h"
+
+#include "../include/hdr_image.h"
+#include "../include/tonemap.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Regrades a linear render written by the raytracer without tracing any
+// rays. Usage:
+//   tonemap [--exposure stops] [--gamma g] [--filmic] [in.pfm] [out.ppm]
+int main(int argc, char** argv) {
+    tonemap_settings settings;
+    std::string in_path = "out.pfm";
+    std::string out_path = "out.ppm";
+    int positional = 0;
+
+    for (int k = 1; k < argc; k++) {
+        if (std::strcmp(argv[k], "--exposure") == 0 && k + 1 < argc) {
+            settings.exposure = std::atof(argv[++k]);
+        } else if (std::strcmp(argv[k], "--gamma") == 0 && k + 1 < argc) {
+            settings.gamma = std::atof(argv[++k]);
+        } else if (std::strcmp(argv[k], "--filmic") == 0) {
+            settings.filmic = true;
+        } else if (argv[k][0] != '-' && positional < 2) {
+            (positional++ == 0 ? in_path : out_path) = argv[k];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--exposure stops] [--gamma g] [--filmic] [in.pfm] [out.ppm]\n";
+            return 1;
+        }
+    }
+
+    if (settings.gamma <= 0) {
+        std::cerr << "Gamma must be positive\n";
+        return 1;
+    }
+
+    hdr_image image;
+    if (!image.read_pfm(in_path)) {
+        std::cerr << "Could not read " << in_path << '\n';
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<unsigned char> bytes;
+    tonemap(image, settings, bytes);
+    auto end = std::chrono::steady_clock::now();
+
+    std::string out;
+    write_ppm(out, image.width, image.height, bytes);
+
+    std::ofstream outfile(out_path, std::ios::out);
+    if (!outfile.is_open()) {
+        std::cerr << "Could not write " << out_path << '\n';
+        return 1;
+    }
+    outfile << out;
+    outfile.close();
+
+    std::cout << "Tone mapped " << image.width << 'x' << image.height << " in "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms\n";
+
+    return 0;
+}